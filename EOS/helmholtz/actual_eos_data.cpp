@@ -10,16 +10,24 @@ AMREX_GPU_MANAGED amrex::Real helmholtz::ttol;
 AMREX_GPU_MANAGED amrex::Real helmholtz::dtol;
 
 // for the helmholtz free energy tables
-AMREX_GPU_MANAGED amrex::Real helmholtz::f[jmax][imax][9];
+AMREX_GPU_MANAGED const amrex::Real (*helmholtz::f)[imax][9];
 
 // for the pressure derivative with density tables
-AMREX_GPU_MANAGED amrex::Real helmholtz::dpdf[jmax][imax][4];
+AMREX_GPU_MANAGED const amrex::Real (*helmholtz::dpdf)[imax][4];
 
 // for chemical potential tables
-AMREX_GPU_MANAGED amrex::Real helmholtz::ef[jmax][imax][4];
+AMREX_GPU_MANAGED const amrex::Real (*helmholtz::ef)[imax][4];
 
 // for the number density tables
-AMREX_GPU_MANAGED amrex::Real helmholtz::xf[jmax][imax][4];
+AMREX_GPU_MANAGED const amrex::Real (*helmholtz::xf)[imax][4];
+
+AMREX_GPU_MANAGED amrex::Real helmholtz::f_store[jmax][imax][9];
+AMREX_GPU_MANAGED amrex::Real helmholtz::dpdf_store[jmax][imax][4];
+AMREX_GPU_MANAGED amrex::Real helmholtz::ef_store[jmax][imax][4];
+AMREX_GPU_MANAGED amrex::Real helmholtz::xf_store[jmax][imax][4];
+
+AMREX_GPU_MANAGED const helmholtz::helm_cell_t* helmholtz::cells{nullptr};
+void* helmholtz::cells_storage{nullptr};
 
 // for storing the differences
 AMREX_GPU_MANAGED amrex::Real helmholtz::dt_sav[jmax];
@@ -1,5 +1,16 @@
-# Read in the Helmholtz EOS table and create a
-# Fortran module containing the data.
+#!/usr/bin/env python3
+
+# Read in the Helmholtz EOS table and either create a Fortran module
+# containing the data (--format fortran, the default) or write it as a
+# binary table (--format binary) that the C++ EOS can memory-map
+# instead of parsing the text table at startup (set
+# eos.helm_table_file to the binary file).
+#
+# The layout of the binary table is described in helm_table_io.H.
+
+import argparse
+import struct
+import zlib
 
 # Number of density rows
 imax = 541
@@ -7,127 +18,130 @@ imax = 541
 # Number of temperature columns
 jmax = 201
 
-table_name = 'helm_table.dat'
+# the table extent (log10 of temperature and density)
+tlo = 3.0
+thi = 13.0
+dlo = -12.0
+dhi = 15.0
 
-table = open(table_name, 'r')
+# for the binary table
+MAGIC = b'HELMTAB\0'
+ENDIAN_TAG = 0x01020304
+VERSION = 1
 
-# Free energy and its derivatives
+# the order in which the columns of each section of the text table
+# are stored in the C++ arrays: entry m is the text column that goes
+# into slot m
 
-f      = [[None] * jmax for _ in range(imax)]
-fd     = [[None] * jmax for _ in range(imax)]
-ft     = [[None] * jmax for _ in range(imax)]
-fdd    = [[None] * jmax for _ in range(imax)]
-ftt    = [[None] * jmax for _ in range(imax)]
-fdt    = [[None] * jmax for _ in range(imax)]
-fddt   = [[None] * jmax for _ in range(imax)]
-fdtt   = [[None] * jmax for _ in range(imax)]
-fddtt  = [[None] * jmax for _ in range(imax)]
+# f, ft, ftt, fd, fdd, fdt, fddt, fdtt, fddtt
+F_SLOTS = [0, 2, 4, 1, 3, 5, 6, 7, 8]
 
-# Pressure derivatives
+# x, xt, xd, xdt for dpdf, ef, and xf
+X_SLOTS = [0, 2, 1, 3]
 
-dpdf   = [[None] * jmax for _ in range(imax)]
-dpdfd  = [[None] * jmax for _ in range(imax)]
-dpdft  = [[None] * jmax for _ in range(imax)]
-dpdfdt = [[None] * jmax for _ in range(imax)]
 
-# Electron chemical potential
+def read_table(table_name):
+    """read the four sections of the text table.  Each section is a
+    list (over j, then i) of the rows of the table as strings"""
 
-ef     = [[None] * jmax for _ in range(imax)]
-efd    = [[None] * jmax for _ in range(imax)]
-eft    = [[None] * jmax for _ in range(imax)]
-efdt   = [[None] * jmax for _ in range(imax)]
+    sections = []
 
-# Number density
+    with open(table_name, 'r') as table:
+        for ncol in [9, 4, 4, 4]:
+            rows = []
+            for _ in range(jmax * imax):
+                line = table.readline().split()
+                if len(line) < ncol:
+                    raise ValueError(f'error reading {table_name}: the table is truncated')
+                rows.append(line[:ncol])
+            sections.append(rows)
 
-xf     = [[None] * jmax for _ in range(imax)]
-xfd    = [[None] * jmax for _ in range(imax)]
-xft    = [[None] * jmax for _ in range(imax)]
-xfdt   = [[None] * jmax for _ in range(imax)]
+    return sections
 
-for j in range(jmax):
-    for i in range(imax):
 
-        line = table.readline().split()
+def write_fortran(sections, module_file):
+    """write the free energy as a Fortran module"""
 
-        f[i][j]      = line[0]
-        fd[i][j]     = line[1]
-        ft[i][j]     = line[2]
-        fdd[i][j]    = line[3]
-        fdt[i][j]    = line[4]
-        ftt[i][j]    = line[5]
-        fddt[i][j]   = line[6]
-        fdtt[i][j]   = line[7]
-        fddtt[i][j]  = line[8]
+    f = sections[0]
 
-for j in range(jmax):
-    for i in range(imax):
+    with open(module_file, 'w') as module:
 
-        line = table.readline().split()
+        module.write('module helm_table_module\n\n')
 
-        dpdf[i][j]   = line[0]
-        dpdfd[i][j]  = line[1]
-        dpdft[i][j]  = line[2]
-        dpdfdt[i][j] = line[3]
+        module.write('  implicit none\n\n')
 
-for j in range(jmax):
-    for i in range(imax):
+        module.write('  integer, parameter :: imax = {}\n'.format(imax))
+        module.write('  integer, parameter :: jmax = {}\n\n'.format(jmax))
 
-        line = table.readline().split()
+        module.write('  double precision :: f(imax,jmax) = reshape([ &\n    ')
 
-        ef[i][j]     = line[0]
-        efd[i][j]    = line[1]
-        eft[i][j]    = line[2]
-        efdt[i][j]   = line[3]
+        n_per_line = 4
 
-for j in range(jmax):
-    for i in range(imax):
+        k = 0
 
-        line = table.readline().split()
+        for j in range(jmax):
+            for i in range(imax):
+                module.write('{}'.format(f[j * imax + i][0].replace('E', 'd')))
 
-        xf[i][j]     = line[0]
-        xfd[i][j]    = line[1]
-        xft[i][j]    = line[2]
-        xfdt[i][j]   = line[3]
+                if not (i == imax-1 and j == jmax-1):
+                    module.write(', ')
+                else:
+                    module.write('], &\n')
 
-table.close()
+                k += 1
 
+                if k == n_per_line:
+                    module.write(' &\n    ')
+                    k = 0
 
-# Now write out the module
+        module.write('    [imax, jmax])\n\n')
 
-module_file = 'helm_table.F90'
-module = open(module_file, 'w')
+        module.write('end module helm_table_module\n')
 
-module.write('module helm_table_module\n\n')
 
-module.write('  implicit none\n\n')
+def write_binary(sections, binary_file):
+    """write the tables as little-endian doubles, in the layout of the
+    C++ arrays f[jmax][imax][9], dpdf, ef, and xf[jmax][imax][4],
+    preceded by a header with the table dimensions and a checksum"""
 
-module.write('  integer, parameter :: imax = {}\n'.format(imax))
-module.write('  integer, parameter :: jmax = {}\n\n'.format(jmax))
+    data = bytearray()
 
-module.write('  double precision :: f(imax,jmax) = reshape([ &\n    ')
+    for rows, slots in zip(sections, [F_SLOTS, X_SLOTS, X_SLOTS, X_SLOTS]):
+        for row in rows:
+            values = [float(row[col].replace('D', 'E').replace('d', 'e')) for col in slots]
+            data += struct.pack(f'<{len(values)}d', *values)
 
-n_per_line = 4
+    nvalues = len(data) // 8
+    checksum = zlib.crc32(data) & 0xffffffff
 
-k = 0
+    header = struct.pack('<8sIIii4dQII', MAGIC, ENDIAN_TAG, VERSION,
+                         imax, jmax, tlo, thi, dlo, dhi,
+                         nvalues, checksum, 0)
+    assert len(header) == 72
 
-for j in range(jmax):
-    for i in range(imax):
-        module.write('{}'.format(f[i][j].replace('E','d')))
+    with open(binary_file, 'wb') as out:
+        out.write(header)
+        out.write(data)
 
-        if not (i == imax-1 and j == jmax-1):
-            module.write(', ')
-        else:
-            module.write('], &\n')
 
-        k += 1
+def main():
 
-        if k == n_per_line:
-            module.write(' &\n    ')
-            k = 0
+    parser = argparse.ArgumentParser(description='convert the Helmholtz EOS table')
+    parser.add_argument('table', nargs='?', default='helm_table.dat',
+                        help='the text table to read')
+    parser.add_argument('--format', choices=['fortran', 'binary'], default='fortran',
+                        help='write a Fortran module or a binary (memory-mappable) table')
+    parser.add_argument('-o', '--output', default=None,
+                        help='output file (default: helm_table.F90 or helm_table.bin)')
+    args = parser.parse_args()
 
-module.write('    [imax, jmax])\n\n')
+    sections = read_table(args.table)
 
-module.write('end module helm_table_module\n')
+    if args.format == 'binary':
+        write_binary(sections, args.output or 'helm_table.bin')
+    else:
+        write_fortran(sections, args.output or 'helm_table.F90')
 
-module.close()
 
+if __name__ == '__main__':
+    main()
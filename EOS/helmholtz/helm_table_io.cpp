@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#include <AMReX.H>
+
+#include <actual_eos_data.H>
+#include <crc32.H>
+#include <mapped_file.H>
+#include <helm_table_io.H>
+
+namespace
+{
+    // the current mapping, if any
+    const void* map_addr = nullptr;
+
+    void check_header (const helmholtz::helm_table_header_t& hdr,
+                       const std::string& filename)
+    {
+        using namespace helmholtz;
+
+        if (std::memcmp(hdr.magic, helm_table_magic, sizeof(helm_table_magic)) != 0) {
+            amrex::Error(filename + " is not a binary Helmholtz table");
+        }
+
+        if (hdr.endian_tag != helm_table_endian_tag) {
+            amrex::Error(filename + " was written with a different byte order than this machine uses");
+        }
+
+        if (hdr.version != helm_table_version) {
+            amrex::Error(filename + " has an unsupported binary table version");
+        }
+
+        if (hdr.imax != imax || hdr.jmax != jmax ||
+            hdr.tlo != tlo || hdr.thi != thi ||
+            hdr.dlo != dlo || hdr.dhi != dhi ||
+            hdr.nvalues != helm_table_nvalues()) {
+            amrex::Error(filename + " does not match the table dimensions of the Helmholtz EOS");
+        }
+    }
+}
+
+
+std::uint64_t
+helmholtz::helm_table_nvalues ()
+{
+    return static_cast<std::uint64_t>(9 + 4 + 4 + 4) * imax * jmax;
+}
+
+
+bool
+helmholtz::is_binary_helm_table (const std::string& filename)
+{
+    std::ifstream table(filename, std::ios::binary);
+
+    char magic[sizeof(helm_table_magic)];
+    if (!table.read(magic, sizeof(magic))) {
+        return false;
+    }
+
+    return std::memcmp(magic, helm_table_magic, sizeof(helm_table_magic)) == 0;
+}
+
+
+helmholtz::helm_table_header_t
+helmholtz::read_helm_table_header (const std::string& filename)
+{
+    std::ifstream table(filename, std::ios::binary);
+
+    if (!table.is_open()) {
+        amrex::Error(filename + " could not be opened");
+    }
+
+    helm_table_header_t hdr{};
+    if (!table.read(reinterpret_cast<char*>(&hdr), sizeof(hdr))) {
+        amrex::Error("Error reading the header of " + filename);
+    }
+
+    check_header(hdr, filename);
+
+    return hdr;
+}
+
+
+void
+helmholtz::read_helm_table (const std::string& filename, amrex::Real* data)
+{
+    if (is_binary_helm_table(filename)) {
+
+        // the binary table is already in the layout of the arrays
+
+        if constexpr (std::is_same_v<amrex::Real, double>) {
+            read_binary_helm_table(filename, data);
+        } else {
+            std::vector<double> buf(helm_table_nvalues());
+            read_binary_helm_table(filename, buf.data());
+            std::copy(buf.cbegin(), buf.cend(), data);
+        }
+        return;
+    }
+
+    // open the table
+    std::ifstream table;
+    table.open(filename);
+
+    if (!table.is_open()) {
+        // the table was not present or we could not open it; abort
+        amrex::Error(filename + " could not be opened");
+    }
+
+    std::string line;
+
+    // read in the free energy table
+    amrex::Real* f_local = data;
+    int idx = 0;
+    for (int j = 0; j < jmax; ++j) {
+        for (int i = 0; i < imax; ++i) {
+            std::getline(table, line);
+            if (line.empty()) {
+                amrex::Error("Error reading free energy from " + filename);
+            }
+            std::istringstream sdata(line);
+            sdata >> f_local[idx] >> f_local[idx+3] >> f_local[idx+1]
+                  >> f_local[idx+4] >> f_local[idx+2] >> f_local[idx+5]
+                  >> f_local[idx+6] >> f_local[idx+7] >> f_local[idx+8];
+            idx += 9;
+        }
+    }
+
+    // the other three tables have 4 entries at each point, stored as
+    // x, xt, xd, xdt
+
+    const std::string names[3] = {"pressure derivative",
+                                  "electron chemical potential",
+                                  "number density"};
+
+    amrex::Real* x_local = data + static_cast<std::size_t>(9) * imax * jmax;
+
+    for (const auto& name : names) {
+        idx = 0;
+        for (int j = 0; j < jmax; ++j) {
+            for (int i = 0; i < imax; ++i) {
+                std::getline(table, line);
+                if (line.empty()) {
+                    amrex::Error("Error reading " + name + " from " + filename);
+                }
+                std::istringstream sdata(line);
+                sdata >> x_local[idx] >> x_local[idx+2]
+                      >> x_local[idx+1] >> x_local[idx+3];
+                idx += 4;
+            }
+        }
+        x_local += static_cast<std::size_t>(4) * imax * jmax;
+    }
+
+    table.close();
+}
+
+
+void
+helmholtz::read_binary_helm_table (const std::string& filename, double* data)
+{
+    const helm_table_header_t hdr = read_helm_table_header(filename);
+
+    std::ifstream table(filename, std::ios::binary);
+    table.seekg(sizeof(helm_table_header_t));
+
+    const auto nbytes = static_cast<std::streamsize>(hdr.nvalues * sizeof(double));
+    if (!table.read(reinterpret_cast<char*>(data), nbytes)) {
+        amrex::Error("Error reading the data of " + filename);
+    }
+
+    check_helm_table_checksum(filename, data);
+}
+
+
+void
+helmholtz::check_helm_table_checksum (const std::string& filename, const double* data)
+{
+    const helm_table_header_t hdr = read_helm_table_header(filename);
+
+    const std::uint32_t crc = crc32_checksum(data, hdr.nvalues * sizeof(double));
+    if (crc != hdr.checksum) {
+        amrex::Error(filename + " is corrupt (checksum mismatch)");
+    }
+}
+
+
+const double*
+helmholtz::map_binary_helm_table (const std::string& filename)
+{
+    unmap_binary_helm_table();
+
+    const helm_table_header_t hdr = read_helm_table_header(filename);
+
+    const std::size_t len = sizeof(helm_table_header_t) + hdr.nvalues * sizeof(double);
+
+    map_addr = mapped_file::map(filename, len);
+    if (map_addr == nullptr) {
+        return nullptr;
+    }
+
+    return reinterpret_cast<const double*>(static_cast<const char*>(map_addr) + sizeof(helm_table_header_t));
+}
+
+
+void
+helmholtz::unmap_binary_helm_table ()
+{
+    if (map_addr != nullptr) {
+        mapped_file::unmap(map_addr);
+    }
+    map_addr = nullptr;
+}
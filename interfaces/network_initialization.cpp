@@ -5,6 +5,16 @@
 #else
 #include <actual_rhs.H>
 #endif
+#ifdef NETWORK_HAS_RATE_VECTOR
+#include <reaclib_temp_table.H>
+
+// the Reaclib tables are only used by the networks whose
+// evaluate_rates() calls fill_reaclib_rates_dispatch() -- a network
+// regenerated by pynucastro calls fill_reaclib_rates() directly
+#if defined(REACLIB_TABLE) && !defined(REACLIB_RATES_DISPATCH_H)
+#error "USE_REACLIB_TABLE=TRUE needs a network whose evaluate_rates() calls fill_reaclib_rates_dispatch()"
+#endif
+#endif
 #ifdef NONAKA_PLOT
 #include <nonaka_plot.H>
 #endif
@@ -29,6 +39,15 @@ nonaka_init();
 #else
     actual_network_init();
     actual_rhs_init();
+#ifdef NETWORK_HAS_RATE_VECTOR
+#ifndef REACLIB_RATES_DISPATCH_H
+    if (network_rp::use_tables) {
+        amrex::Error("network.use_tables needs a network whose evaluate_rates() calls fill_reaclib_rates_dispatch()");
+    }
+#endif
+    // tabulate the Reaclib rates in temperature (if network.use_tables)
+    reaclib_temp_table_init();
+#endif
 #endif
 
 #ifdef NSE_TABLE
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <AMReX.H>
+#include <AMReX_Arena.H>
+#include <AMReX_Print.H>
+
+#include <extern_parameters.H>
+
+#ifdef NETWORK_HAS_RATE_VECTOR
+
+#include <reaclib_rates.H>
+#include <reaclib_temp_table.H>
+#include <partition_function_temps.H>
+
+namespace reaclib_temp_table
+{
+    AMREX_GPU_MANAGED amrex::Real* data{nullptr};
+
+    AMREX_GPU_MANAGED int nseg{0};
+    AMREX_GPU_MANAGED amrex::Real seg_lnt[max_segments+1];
+    AMREX_GPU_MANAGED amrex::Real seg_dlnt[max_segments];
+    AMREX_GPU_MANAGED int seg_first[max_segments];
+    AMREX_GPU_MANAGED int seg_nint[max_segments];
+
+    AMREX_GPU_MANAGED amrex::Real tmin{0.0_rt};
+    AMREX_GPU_MANAGED amrex::Real tmax{0.0_rt};
+}
+
+namespace
+{
+    ///
+    /// (ln r, d ln r / d ln T) for all of the rates at temp, evaluated
+    /// analytically, into row[0 : 2 NumRates]
+    ///
+    void analytic_row (const amrex::Real temp, amrex::Real* row)
+    {
+        using namespace reaclib_temp_table;
+
+        const tf_t tfactors = evaluate_tfactors(temp);
+
+        rate_derivs_t rates;
+        for (int n = 1; n <= Rates::NumRates; ++n) {
+            rates.screened_rates(n) = 0.0_rt;
+            rates.dscreened_rates_dT(n) = 0.0_rt;
+        }
+
+        fill_reaclib_rates<1, rate_derivs_t>(tfactors, rates);
+
+        for (int n = 1; n <= Rates::NumRates; ++n) {
+            const amrex::Real r = rates.screened_rates(n);
+            if (r > 0.0_rt && std::isfinite(r)) {
+                row[2*(n-1)] = std::log(r);
+                row[2*(n-1)+1] = temp * rates.dscreened_rates_dT(n) / r;
+            } else if (r > 0.0_rt) {
+                // some of the Reaclib fits overflow far outside of
+                // their range of temperatures
+                row[2*(n-1)] = ln_huge;
+                row[2*(n-1)+1] = 0.0_rt;
+            } else {
+                row[2*(n-1)] = 2.0_rt * ln_zero;
+                row[2*(n-1)+1] = 0.0_rt;
+            }
+        }
+    }
+}
+
+void reaclib_temp_table_init ()
+{
+    using namespace reaclib_temp_table;
+
+    if (! network_rp::use_tables) {
+        return;
+    }
+
+    if (network_rp::rate_table_tmin <= 0.0_rt ||
+        network_rp::rate_table_tmax <= network_rp::rate_table_tmin) {
+        amrex::Error("network.rate_table_tmax must be larger than network.rate_table_tmin > 0");
+    }
+
+    // the segment boundaries: the ends of the table and the
+    // temperatures of the partition functions in between (see
+    // networks/write_partition_temps.py)
+
+    std::vector<amrex::Real> bounds;
+    for (const amrex::Real t9 : part_fun_temps::temps) {
+        const amrex::Real temp = t9 * 1.0e9_rt;
+        if (temp > network_rp::rate_table_tmin && temp < network_rp::rate_table_tmax) {
+            bounds.push_back(temp);
+        }
+    }
+    bounds.push_back(network_rp::rate_table_tmin);
+    bounds.push_back(network_rp::rate_table_tmax);
+    std::sort(bounds.begin(), bounds.end());
+
+    const int ns = static_cast<int>(bounds.size()) - 1;
+
+    if (ns > max_segments) {
+        amrex::Error("the Reaclib rate table has too many segments -- increase reaclib_temp_table::max_segments");
+    }
+
+    // the segment ends are evaluated this far inside of the segment,
+    // so that they see the partition functions of the segment
+
+    const amrex::Real inset = 1.e-12_rt;
+
+    // outside of this range of ln r, the relative error of a rate is
+    // not counted -- the generated rates clip each Reaclib set at
+    // 1.e-100, which is a kink in ln r, and the rates this large are
+    // fits used far outside of their range of temperatures, some of
+    // which overflow
+
+    const amrex::Real ln_small = -200.0_rt;
+    const amrex::Real ln_large = 200.0_rt;
+
+    std::vector<amrex::Real> table;
+    std::vector<amrex::Real> mid(row_size);
+
+    std::vector<amrex::Real> lnt(ns+1);
+    std::vector<amrex::Real> dlnt(ns);
+    std::vector<int> first(ns);
+    std::vector<int> nint(ns);
+
+    for (int k = 0; k <= ns; ++k) {
+        lnt[k] = std::log(bounds[k]);
+    }
+
+    int npts = 0;
+    amrex::Real max_err = 0.0_rt;
+    amrex::Real max_slope_err = 0.0_rt;
+
+    for (int per_decade = 25; ; per_decade *= 2) {
+
+        npts = 0;
+        for (int k = 0; k < ns; ++k) {
+            const amrex::Real ndecades = (lnt[k+1] - lnt[k]) / std::log(10.0_rt);
+            nint[k] = amrex::max(1, static_cast<int>(std::ceil(ndecades * per_decade)));
+            dlnt[k] = (lnt[k+1] - lnt[k]) / static_cast<amrex::Real>(nint[k]);
+            first[k] = npts;
+            npts += nint[k] + 1;
+        }
+
+        table.resize(static_cast<std::size_t>(npts) * row_size);
+
+        max_err = 0.0_rt;
+        max_slope_err = 0.0_rt;
+
+        for (int k = 0; k < ns; ++k) {
+            for (int i = 0; i <= nint[k]; ++i) {
+                amrex::Real temp;
+                if (i == 0) {
+                    temp = bounds[k] * (1.0_rt + inset);
+                } else if (i == nint[k]) {
+                    temp = bounds[k+1] * (1.0_rt - inset);
+                } else {
+                    temp = std::exp(lnt[k] + i * dlnt[k]);
+                }
+                analytic_row(temp, table.data() + static_cast<std::size_t>(first[k] + i) * row_size);
+            }
+
+            // the interpolation error of ln r is largest halfway
+            // between the points, and that of the slope at
+            // t = 1/2 -+ 1/sqrt(12)
+
+            const amrex::Real ts = 0.5_rt - 1.0_rt / std::sqrt(12.0_rt);
+
+            const hermite_t interp(0.5_rt, dlnt[k]);
+            const hermite_t interp_s(ts, dlnt[k]);
+
+            for (int i = 0; i < nint[k]; ++i) {
+                const amrex::Real* y0 = table.data() + static_cast<std::size_t>(first[k] + i) * row_size;
+                const amrex::Real* y1 = y0 + row_size;
+
+                analytic_row(std::exp(lnt[k] + (i + 0.5_rt) * dlnt[k]), mid.data());
+
+                for (int r = 0; r < Rates::NumRates; ++r) {
+                    if (mid[2*r] > ln_small && mid[2*r] < ln_large) {
+                        const amrex::Real lnr = interp.value(y0 + 2*r, y1 + 2*r);
+                        max_err = amrex::max(max_err, std::abs(std::expm1(lnr - mid[2*r])));
+                    }
+                }
+
+                analytic_row(std::exp(lnt[k] + (i + ts) * dlnt[k]), mid.data());
+
+                for (int r = 0; r < Rates::NumRates; ++r) {
+                    if (mid[2*r] > ln_small && mid[2*r] < ln_large) {
+                        const amrex::Real slope = interp_s.slope(y0 + 2*r, y1 + 2*r);
+                        max_slope_err = amrex::max(max_slope_err,
+                                                   std::abs(slope - mid[2*r+1]) /
+                                                   amrex::max(1.0_rt, std::abs(mid[2*r+1])));
+                    }
+                }
+            }
+        }
+
+        if ((max_err <= network_rp::rate_table_rtol &&
+             max_slope_err <= network_rp::rate_table_slope_rtol) ||
+            2 * per_decade > network_rp::rate_table_max_per_decade) {
+            break;
+        }
+    }
+
+    amrex::Print() << "tabulated the Reaclib rates at " << npts << " temperatures in "
+                   << ns << " segments of [" << network_rp::rate_table_tmin << ", "
+                   << network_rp::rate_table_tmax << "], largest relative interpolation error "
+                   << max_err << " (rates), " << max_slope_err << " (slopes)" << std::endl;
+
+    if (max_err > network_rp::rate_table_rtol || max_slope_err > network_rp::rate_table_slope_rtol) {
+        amrex::Warning("the Reaclib rate table does not meet network.rate_table_rtol or "
+                       "network.rate_table_slope_rtol -- increase network.rate_table_max_per_decade");
+    }
+
+    reaclib_temp_table_finalize();
+
+    data = static_cast<amrex::Real*>(amrex::The_Managed_Arena()->alloc(table.size() * sizeof(amrex::Real)));
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        data[i] = table[i];
+    }
+
+    nseg = ns;
+    for (int k = 0; k < ns; ++k) {
+        seg_lnt[k] = lnt[k];
+        seg_dlnt[k] = dlnt[k];
+        seg_first[k] = first[k];
+        seg_nint[k] = nint[k];
+    }
+    seg_lnt[ns] = lnt[ns];
+
+    tmin = network_rp::rate_table_tmin;
+    tmax = network_rp::rate_table_tmax;
+
+    static bool registered = false;
+    if (!registered) {
+        amrex::ExecOnFinalize(reaclib_temp_table_finalize);
+        registered = true;
+    }
+}
+
+void reaclib_temp_table_finalize ()
+{
+    using namespace reaclib_temp_table;
+
+    if (data != nullptr) {
+        amrex::The_Managed_Arena()->free(data);
+        data = nullptr;
+    }
+    nseg = 0;
+}
+
+#endif
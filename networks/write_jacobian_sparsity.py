@@ -0,0 +1,566 @@
+#!/usr/bin/env python3
+
+"""Extract the sparsity pattern of the network Jacobian and write it,
+together with the fill-in produced by an LU factorization without
+pivoting, as a compressed-sparse-row (CSR) structure to
+jacobian_sparsity.H.  This is the symbolic factorization used by the
+sparse linear algebra in integration/utils/sparse_jacobian.H.
+
+For pynucastro-generated networks, the nonzero species-species
+entries are found by scanning the jac.set(A, B, ...) calls in the
+network's jac_nuc().  For all other networks we fall back to a dense
+pattern.  The energy row and column are always assumed to be full.
+
+To limit the fill-in, the species are put in a minimum degree
+ordering, with the energy equation (which couples to everything)
+last.  Since the pattern is fixed, the numerical factorization and
+solve are then written out as straight-line code that only touches
+the stored entries.
+
+With --coloring, this instead writes jacobian_coloring.H, a
+Curtis-Powell-Reid (CPR) coloring of the species columns of the same
+pattern for the numerical Jacobian: columns of the same color share no
+nonzero species row, so they can be perturbed together and recovered
+from a single RHS evaluation.  Since the species mass fractions sum to
+1, one species row can be left out of the coloring and recovered from
+the others afterwards -- we pick the densest one.  The energy row
+couples to every species, but its nuclear part follows from the
+species block, so only the columns whose energy generation has
+another dependence on the composition (the weak rate energy losses)
+need a color of their own.
+"""
+
+import os
+import re
+import argparse
+
+from general_null import network_param_file
+
+
+JAC_SET_RE = re.compile(r"jac\.set\(\s*(\w+)\s*,\s*(\w+)\s*,")
+ENUC_WEAK_RE = re.compile(r"enuc_weak\s*\+=.*?\bY\(\s*(\w+)\s*\)")
+
+
+def get_species(net_file, defines):
+    """return the list of species names as they appear in the Species
+    enum (1-based)"""
+
+    species = []
+    extra_species = []
+    aux_vars = []
+
+    network_param_file.parse(species, extra_species, aux_vars,
+                             net_file, defines)
+
+    return [s.short_name.capitalize() for s in species]
+
+
+def get_pattern(rhs_file, species, full_species_block=False):
+    """return the set of (row, col) pairs, 1-based, that are
+    structurally nonzero in the Jacobian, including the energy row and
+    column and the full diagonal.  If full_species_block is set, every
+    species-species pair is included as well"""
+
+    nspec = len(species)
+    neqs = nspec + 1
+    index = {name: n+1 for n, name in enumerate(species)}
+
+    pattern = set()
+
+    if os.path.isfile(rhs_file):
+        with open(rhs_file) as f:
+            for m in JAC_SET_RE.finditer(f.read()):
+                row, col = m.groups()
+                if row in index and col in index:
+                    pattern.add((index[row], index[col]))
+
+    if not pattern:
+        # no explicit structure -- treat the Jacobian as dense
+        return {(i, j) for i in range(1, neqs+1) for j in range(1, neqs+1)}, False
+
+    for i in range(1, neqs+1):
+        pattern.add((i, i))
+        pattern.add((i, neqs))
+        pattern.add((neqs, i))
+
+    if full_species_block:
+        # for SDC, the integrator converts the temperature derivatives
+        # to energy derivatives by adding -dedX_n * dydot_m/de to
+        # every species column, which fills the species block
+        for i in range(1, nspec+1):
+            for j in range(1, nspec+1):
+                pattern.add((i, j))
+
+    return pattern, True
+
+
+def get_energy_columns(rhs_file, species):
+    """return the set of species columns, 1-based, that the energy
+    generation depends on other than through dY/dt: the parents of
+    the tabulated weak rates, whose energy losses are added to
+    enuc_weak"""
+
+    index = {name: n+1 for n, name in enumerate(species)}
+
+    cols = set()
+
+    if os.path.isfile(rhs_file):
+        with open(rhs_file) as f:
+            for m in ENUC_WEAK_RE.finditer(f.read()):
+                if m.group(1) in index:
+                    cols.add(index[m.group(1)])
+
+    return cols
+
+
+def order_to_perm(order, neqs):
+    """convert a list of equations in elimination order into perm,
+    where perm[i] is the (1-based) position of equation i"""
+
+    perm = [0] * (neqs+1)
+    for pos, i in enumerate(order):
+        perm[i] = pos + 1
+
+    return perm
+
+
+def degree_ordering(pattern, neqs):
+    """order the species by their number of off-diagonal couplings in
+    the original pattern"""
+
+    degree = [0] * (neqs+1)
+    for i, j in pattern:
+        if i != j:
+            degree[i] += 1
+            degree[j] += 1
+
+    order = sorted(range(1, neqs), key=lambda i: (degree[i], i)) + [neqs]
+
+    return order_to_perm(order, neqs)
+
+
+def minimum_degree_ordering(pattern, neqs):
+    """order the species by minimum degree on the (symmetrized)
+    elimination graph -- at each step we eliminate the species with
+    the fewest remaining couplings and connect all of its neighbors"""
+
+    # the energy equation is always eliminated last, so leave it out
+    # of the graph
+
+    adj = {i: set() for i in range(1, neqs)}
+    for i, j in pattern:
+        if i != j and i != neqs and j != neqs:
+            adj[i].add(j)
+            adj[j].add(i)
+
+    order = []
+    while adj:
+        v = min(adj, key=lambda i: (len(adj[i]), i))
+        neighbors = adj.pop(v)
+        for i in neighbors:
+            adj[i] |= neighbors
+            adj[i].discard(i)
+            adj[i].discard(v)
+        order.append(v)
+
+    order.append(neqs)
+
+    return order_to_perm(order, neqs)
+
+
+def count_ops(rows, neqs):
+    """number of multiply-adds in the numerical factorization"""
+
+    nops = 0
+    for i in range(1, neqs+1):
+        for k in rows[i]:
+            if k < i:
+                nops += 1 + sum(1 for j in rows[k] if j > k)
+
+    return nops
+
+
+def symbolic_lu(pattern, perm, neqs):
+    """add the fill-in created by an LU factorization without pivoting
+    in the elimination order given by perm.  The result is indexed by
+    position in the elimination order."""
+
+    rows = [set() for _ in range(neqs+1)]
+    for i, j in pattern:
+        rows[perm[i]].add(perm[j])
+
+    for k in range(1, neqs+1):
+        upper = [j for j in rows[k] if j > k]
+        for i in range(k+1, neqs+1):
+            if k in rows[i]:
+                rows[i].update(upper)
+
+    return rows
+
+
+def csr(rows, neqs):
+    """return the row pointers, column indices, and location of the
+    diagonal for the CSR representation of rows"""
+
+    row_count = [0]
+    col_index = []
+    diag_index = []
+
+    for i in range(1, neqs+1):
+        cols = sorted(rows[i])
+        diag_index.append(row_count[-1] + cols.index(i))
+        col_index += cols
+        row_count.append(row_count[-1] + len(cols))
+
+    return row_count, col_index, diag_index
+
+
+def color_columns(pattern, nspec, skip_row=0, alone=()):
+    """greedy coloring of the species columns such that no two columns
+    of the same color have a nonzero in the same species row (the
+    energy row and skip_row are left out), and the columns in alone
+    each have a color of their own.  Returns the color (0-based) of
+    each column, indexed from 1."""
+
+    col_rows = {j: {i for i, jj in pattern if jj == j and i <= nspec and i != skip_row}
+                for j in range(1, nspec+1)}
+
+    # two columns conflict if they share a row
+
+    adj = {j: set() for j in range(1, nspec+1)}
+    for i in range(1, nspec+1):
+        cols = [j for j in range(1, nspec+1) if i in col_rows[j]]
+        for j in cols:
+            adj[j].update(c for c in cols if c != j)
+
+    for j in alone:
+        for c in range(1, nspec+1):
+            if c != j:
+                adj[j].add(c)
+                adj[c].add(j)
+
+    best = None
+
+    # the greedy coloring depends on the order the columns are
+    # visited, so try both the natural order and largest degree first
+    # and keep whichever needs fewer colors
+
+    for order in (list(range(1, nspec+1)),
+                  sorted(range(1, nspec+1), key=lambda j: (-len(adj[j]), j))):
+        color = [0] * (nspec+1)
+        for j in order:
+            used = {color[c] for c in adj[j] if color[c] > 0}
+            c = 1
+            while c in used:
+                c += 1
+            color[j] = c
+
+        if best is None or max(color) < max(best):
+            best = color
+
+    return [0] + [c - 1 for c in best[1:]]
+
+
+def write_coloring_header(pattern, nspec, structured, energy_cols, net, header_name):
+    """output the column coloring and the species pattern of each
+    column.  The columns in energy_cols get a color of their own, so
+    their energy row can be differenced directly."""
+
+    color = color_columns(pattern, nspec, alone=energy_cols)
+    ncolors = max(color[1:]) + 1
+
+    # the rows of the light particles (n, p, alpha) usually couple to
+    # nearly every species, which forces every column into its own
+    # color.  One of them can be recovered from mass conservation
+    # instead, so try leaving out the densest row.
+
+    mass_row = 0
+    if structured:
+        row_count = [0] * (nspec+1)
+        for i, j in pattern:
+            if i <= nspec and j <= nspec:
+                row_count[i] += 1
+        densest = max(range(1, nspec+1), key=lambda i: (row_count[i], -i))
+
+        c = color_columns(pattern, nspec, skip_row=densest, alone=energy_cols)
+        if max(c[1:]) + 1 < ncolors:
+            color = c
+            ncolors = max(c[1:]) + 1
+            mass_row = densest
+
+    color_start = [0]
+    color_cols = []
+    for c in range(ncolors):
+        color_cols += [j for j in range(1, nspec+1) if color[j] == c]
+        color_start.append(len(color_cols))
+
+    col_start = [0]
+    col_rows = []
+    for j in range(1, nspec+1):
+        col_rows += sorted(i for i, jj in pattern if jj == j and i <= nspec and i != mass_row)
+        col_start.append(len(col_rows))
+
+    def wrap(values, indent="       "):
+        chunks = [values[i:i+16] for i in range(0, len(values), 16)]
+        return f",\n{indent}".join(", ".join(str(v) for v in c) for c in chunks)
+
+    with open(header_name, "w") as of:
+        of.write("/* Do not edit -- this is automatically generated by write_jacobian_sparsity.py\n")
+        of.write("   at compile time */\n\n")
+        of.write("#ifndef JACOBIAN_COLORING_H\n")
+        of.write("#define JACOBIAN_COLORING_H\n\n")
+        of.write("#include <AMReX_REAL.H>\n\n")
+        of.write("#include <network_properties.H>\n\n")
+        of.write("using namespace amrex::literals;\n\n")
+        of.write(f"// network: {net}\n")
+        of.write(f"// species columns: {nspec}, colors: {ncolors}\n\n")
+        of.write(f"constexpr int NETWORK_JAC_NCOLORS = {ncolors};\n\n")
+        of.write("// the species row that is not colored but found from mass\n")
+        of.write("// conservation (0 if none)\n")
+        of.write(f"constexpr int NETWORK_JAC_MASS_ROW = {mass_row};\n\n")
+        of.write("namespace {\n\n")
+
+        of.write("    // the species columns of color c (0-based) are\n")
+        of.write("    // jac_color_cols[jac_color_start[c]] ... jac_color_cols[jac_color_start[c+1]-1]\n")
+        of.write(f"    MICROPHYSICS_UNUSED HIP_CONSTEXPR AMREX_GPU_MANAGED int jac_color_start[{ncolors+1}] = {{\n")
+        of.write(f"       {wrap(color_start)}\n")
+        of.write("    };\n\n")
+
+        of.write(f"    MICROPHYSICS_UNUSED HIP_CONSTEXPR AMREX_GPU_MANAGED int jac_color_cols[{nspec}] = {{\n")
+        of.write(f"       {wrap(color_cols)}\n")
+        of.write("    };\n\n")
+
+        of.write("    // the nonzero species rows (other than NETWORK_JAC_MASS_ROW) of species column j are\n")
+        of.write("    // jac_col_rows[jac_col_start[j-1]] ... jac_col_rows[jac_col_start[j]-1]\n")
+        of.write(f"    MICROPHYSICS_UNUSED HIP_CONSTEXPR AMREX_GPU_MANAGED int jac_col_start[{nspec+1}] = {{\n")
+        of.write(f"       {wrap(col_start)}\n")
+        of.write("    };\n\n")
+
+        of.write(f"    MICROPHYSICS_UNUSED HIP_CONSTEXPR AMREX_GPU_MANAGED int jac_col_rows[{len(col_rows)}] = {{\n")
+        of.write(f"       {wrap(col_rows)}\n")
+        of.write("    };\n\n")
+
+        of.write("}\n\n")
+
+        # the energy row is full, so it cannot be colored.  For
+        # networks with an explicit structure (pynucastro), the nuclear
+        # part of the energy generation is the linear function
+        # ener_gener_rate() of dY/dt, so its derivatives follow from the
+        # species block.
+
+        of.write("// the nuclear energy generation rate corresponding to dY/dt.  The\n")
+        of.write("// numerical Jacobian uses this to get the energy row of the columns\n")
+        of.write("// of a color with several columns from the species block; the\n")
+        of.write("// columns with any other energy dependence have a color of their\n")
+        of.write("// own.  This must be included after the network's actual_rhs.H.\n\n")
+        of.write("template <typename T>\n")
+        of.write("AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE\n")
+        of.write("amrex::Real jac_coloring_nuclear_energy ([[maybe_unused]] const T& dydt)\n")
+        of.write("{\n")
+        if structured:
+            of.write("    amrex::Real enuc;\n")
+            of.write("    ener_gener_rate(dydt, enuc);\n")
+            of.write("    return enuc;\n")
+        else:
+            of.write("    // no structure is known for this network, so every color is a\n")
+            of.write("    // single column and the energy row is differenced directly\n")
+            of.write("    return 0.0_rt;\n")
+        of.write("}\n\n")
+        of.write("#endif\n")
+
+
+def write_header(rows, perm, neqs, n_orig, net, header_name):
+    """output the CSR structure and the unrolled factor / solve"""
+
+    row_count, col_index, diag_index = csr(rows, neqs)
+    nnz = len(col_index)
+
+    # location of (i, j) in the value array
+
+    loc = {}
+    for i in range(1, neqs+1):
+        for p in range(row_count[i-1], row_count[i]):
+            loc[(i, col_index[p])] = p
+
+    def wrap(values, indent="       "):
+        chunks = [values[i:i+16] for i in range(0, len(values), 16)]
+        return f",\n{indent}".join(", ".join(str(v) for v in c) for c in chunks)
+
+    with open(header_name, "w") as of:
+        of.write("/* Do not edit -- this is automatically generated by write_jacobian_sparsity.py\n")
+        of.write("   at compile time */\n\n")
+        of.write("#ifndef JACOBIAN_SPARSITY_H\n")
+        of.write("#define JACOBIAN_SPARSITY_H\n\n")
+        of.write("#include <AMReX_REAL.H>\n\n")
+        of.write("#include <network_properties.H>\n\n")
+        of.write("using namespace amrex::literals;\n\n")
+        of.write(f"// network: {net}\n")
+        of.write(f"// nonzeros in the Jacobian: {n_orig} of {neqs*neqs}\n")
+        of.write(f"// nonzeros after LU fill-in: {nnz}\n")
+        of.write(f"// multiply-adds in the LU factorization: {count_ops(rows, neqs)}\n\n")
+        of.write(f"constexpr int NETWORK_SPARSE_JAC_NNZ = {nnz};\n\n")
+        of.write("namespace {\n\n")
+
+        iperm = [0] * neqs
+        for i in range(1, neqs+1):
+            iperm[perm[i]-1] = i
+
+        of.write("    // position in the elimination order of equation i is csr_jac_perm[i-1]\n")
+        of.write(f"    MICROPHYSICS_UNUSED HIP_CONSTEXPR AMREX_GPU_MANAGED int csr_jac_perm[{neqs}] = {{\n")
+        of.write(f"       {wrap(perm[1:])}\n")
+        of.write("    };\n\n")
+
+        of.write("    // equation eliminated at position p is csr_jac_iperm[p-1]\n")
+        of.write(f"    MICROPHYSICS_UNUSED HIP_CONSTEXPR AMREX_GPU_MANAGED int csr_jac_iperm[{neqs}] = {{\n")
+        of.write(f"       {wrap(iperm)}\n")
+        of.write("    };\n\n")
+
+        of.write("    // the remaining arrays describe the matrix with rows and columns\n")
+        of.write("    // permuted into elimination order\n\n")
+
+        of.write("    // offset into the value array of the first entry of row i (i = 1, ..., N)\n")
+        of.write("    // is csr_jac_row_count[i-1]; the last element is the number of nonzeros\n")
+        of.write(f"    MICROPHYSICS_UNUSED HIP_CONSTEXPR AMREX_GPU_MANAGED int csr_jac_row_count[{neqs+1}] = {{\n")
+        of.write(f"       {wrap(row_count)}\n")
+        of.write("    };\n\n")
+
+        of.write("    // 1-based column of each stored entry, sorted within a row\n")
+        of.write(f"    MICROPHYSICS_UNUSED HIP_CONSTEXPR AMREX_GPU_MANAGED int csr_jac_col_index[{nnz}] = {{\n")
+        of.write(f"       {wrap(col_index)}\n")
+        of.write("    };\n\n")
+
+        of.write("    // offset into the value array of the diagonal entry of row i\n")
+        of.write(f"    MICROPHYSICS_UNUSED HIP_CONSTEXPR AMREX_GPU_MANAGED int csr_jac_diag_index[{neqs}] = {{\n")
+        of.write(f"       {wrap(diag_index)}\n")
+        of.write("    };\n\n")
+
+        of.write("}\n\n")
+
+        # the factorization: row-by-row (IKJ) Gaussian elimination.
+        # For each entry L(i,k) left of the diagonal, in increasing k,
+        # we form the multiplier and subtract L(i,k) * U(k,:) from
+        # row i.  The pattern already contains all fill-in, so every
+        # (i, j) we touch exists.
+
+        of.write("// test for a zero pivot.  This is overloaded for the batched value\n")
+        of.write("// types, which check each lane separately after the factorization.\n\n")
+        of.write("AMREX_GPU_HOST_DEVICE AMREX_FORCE_INLINE\n")
+        of.write("bool sparse_lu_zero_pivot (const amrex::Real x)\n")
+        of.write("{\n")
+        of.write("    return x == 0.0_rt;\n")
+        of.write("}\n\n")
+
+        of.write("// LU factorization, in place and without pivoting, of the values a[]\n")
+        of.write("// stored in the CSR layout above.  Returns 0 on success, or the\n")
+        of.write("// (elimination order) row where a zero pivot was found.\n\n")
+        of.write("template <typename T>\n")
+        of.write("AMREX_GPU_HOST_DEVICE AMREX_INLINE\n")
+        of.write("int sparse_lu_factor (T* a)\n")
+        of.write("{\n")
+        of.write(f"    T rdiag[{neqs}];\n")
+
+        for i in range(1, neqs+1):
+            of.write(f"\n    // row {i}\n")
+            for p in range(row_count[i-1], diag_index[i-1]):
+                k = col_index[p]
+                of.write(f"    a[{p}] *= rdiag[{k-1}];\n")
+                for r in range(diag_index[k-1]+1, row_count[k]):
+                    j = col_index[r]
+                    of.write(f"    a[{loc[(i, j)]}] -= a[{p}] * a[{r}];\n")
+            d = diag_index[i-1]
+            of.write(f"    if (sparse_lu_zero_pivot(a[{d}])) {{\n")
+            of.write(f"        return {i};\n")
+            of.write("    }\n")
+            if i < neqs:
+                of.write(f"    rdiag[{i-1}] = 1.0_rt / a[{d}];\n")
+
+        of.write("\n    return 0;\n")
+        of.write("}\n\n")
+
+        of.write("// solve L U x = b using the factorization from sparse_lu_factor.\n")
+        of.write("// x comes in holding b, in elimination order, and is overwritten.\n\n")
+        of.write("template <typename T>\n")
+        of.write("AMREX_GPU_HOST_DEVICE AMREX_INLINE\n")
+        of.write("void sparse_lu_solve (const T* a, T* x)\n")
+        of.write("{\n")
+        of.write("    // forward substitution with the unit lower triangle\n\n")
+        for i in range(1, neqs+1):
+            for p in range(row_count[i-1], diag_index[i-1]):
+                of.write(f"    x[{i-1}] -= a[{p}] * x[{col_index[p]-1}];\n")
+
+        of.write("\n    // backward substitution with the upper triangle\n\n")
+        for i in range(neqs, 0, -1):
+            for p in range(diag_index[i-1]+1, row_count[i]):
+                of.write(f"    x[{i-1}] -= a[{p}] * x[{col_index[p]-1}];\n")
+            of.write(f"    x[{i-1}] /= a[{diag_index[i-1]}];\n")
+
+        of.write("}\n\n")
+        of.write("#endif\n")
+
+
+def main():
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--microphysics_path", type=str, default="",
+                        help="path to Microphysics/")
+    parser.add_argument("--net", type=str, default="",
+                        help="name of the network")
+    parser.add_argument("--odir", type=str, default="",
+                        help="output directory")
+    parser.add_argument("--defines", type=str, default="",
+                        help="any preprocessor defines")
+    parser.add_argument("--coloring", action="store_true",
+                        help="write the column coloring for the numerical Jacobian (jacobian_coloring.H)")
+
+    args = parser.parse_args()
+
+    micro_path = args.microphysics_path
+    net = args.net
+
+    net_file = os.path.join(micro_path, "networks", net, f"{net}.net")
+    if not os.path.isfile(net_file):
+        net_file = os.path.join(micro_path, "networks", net, "pynucastro.net")
+
+    rhs_file = os.path.join(micro_path, "networks", net, "actual_rhs.H")
+
+    species = get_species(net_file, args.defines)
+    neqs = len(species) + 1
+
+    try:
+        os.makedirs(args.odir)
+    except FileExistsError:
+        pass
+
+    if args.coloring:
+        # the coloring only describes the nuclear RHS, so it never
+        # needs the SDC fill-in
+        pattern, structured = get_pattern(rhs_file, species)
+        energy_cols = get_energy_columns(rhs_file, species)
+        write_coloring_header(pattern, len(species), structured, energy_cols, net,
+                              os.path.join(args.odir, "jacobian_coloring.H"))
+        return
+
+    # the SDC Jacobian has the energy correction applied to every
+    # species column, so it needs the full species block
+    sdc = "-DSDC" in args.defines.split()
+    pattern, _ = get_pattern(rhs_file, species, full_species_block=sdc)
+
+    # minimum degree usually gives the least fill-in, but it is a
+    # heuristic, so also consider a static degree ordering and keep
+    # whichever needs less work
+
+    perm = None
+    rows = None
+    for order in (minimum_degree_ordering, degree_ordering):
+        p = order(pattern, neqs)
+        r = symbolic_lu(pattern, p, neqs)
+        if rows is None or count_ops(r, neqs) < count_ops(rows, neqs):
+            perm = p
+            rows = r
+
+    write_header(rows, perm, neqs, len(pattern), net,
+                 os.path.join(args.odir, "jacobian_sparsity.H"))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+
+"""Collect the temperatures at which the partition functions of a
+pynucastro network are tabulated (every temp_array_N in its
+partition_functions.H) and write them to partition_function_temps.H.
+
+The partition functions are interpolated linearly between these
+temperatures, so the derived rates have a kink in their slope there,
+and the temperature table of the Reaclib rates
+(networks/reaclib_temp_table.H) is split into segments at them.  A
+network without partition functions gets an empty list.
+"""
+
+import os
+import re
+import argparse
+
+
+TEMP_ARRAY_RE = re.compile(r"\btemp_array_\d+\s*\[\s*\w+\s*\]\s*=\s*\{(.*?)\};", re.DOTALL)
+
+
+def get_temps(pf_file):
+    """return the sorted temperatures (T9) of all of the temp_array_N
+    in pf_file"""
+
+    temps = set()
+
+    if os.path.isfile(pf_file):
+        with open(pf_file) as f:
+            for m in TEMP_ARRAY_RE.finditer(f.read()):
+                for v in m.group(1).split(","):
+                    if v.strip():
+                        temps.add(float(v))
+
+    return sorted(temps)
+
+
+def write_header(temps, net, header_name):
+    """output the temperatures as a constexpr array"""
+
+    with open(header_name, "w") as of:
+        of.write("/* Do not edit -- this is automatically generated by write_partition_temps.py\n")
+        of.write("   at compile time */\n\n")
+        of.write("#ifndef PARTITION_FUNCTION_TEMPS_H\n")
+        of.write("#define PARTITION_FUNCTION_TEMPS_H\n\n")
+        of.write("#include <array>\n\n")
+        of.write("#include <AMReX_REAL.H>\n\n")
+        of.write("using namespace amrex::literals;\n\n")
+        of.write(f"// network: {net}\n\n")
+        of.write("namespace part_fun_temps\n")
+        of.write("{\n")
+        of.write("    // the temperatures (T9) at which any of the partition functions\n")
+        of.write("    // are tabulated, in increasing order\n")
+        of.write(f"    constexpr std::array<amrex::Real, {len(temps)}> temps{{\n")
+        for i in range(0, len(temps), 5):
+            of.write("        " + ", ".join(f"{t!r}_rt" for t in temps[i:i+5]) + ",\n")
+        of.write("    };\n")
+        of.write("}\n\n")
+        of.write("#endif\n")
+
+
+def main():
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--microphysics_path", type=str, default="",
+                        help="path to Microphysics/")
+    parser.add_argument("--net", type=str, default="",
+                        help="name of the network")
+    parser.add_argument("--odir", type=str, default="",
+                        help="output directory")
+
+    args = parser.parse_args()
+
+    pf_file = os.path.join(args.microphysics_path, "networks", args.net, "partition_functions.H")
+
+    temps = get_temps(pf_file)
+
+    try:
+        os.makedirs(args.odir)
+    except FileExistsError:
+        pass
+
+    write_header(temps, args.net, os.path.join(args.odir, "partition_function_temps.H"))
+
+
+if __name__ == "__main__":
+    main()
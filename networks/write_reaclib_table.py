@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+
+"""Extract the Reaclib coefficients of a pynucastro network from its
+reaclib_rates.H and write them, as a single table, to
+reaclib_rate_table.H.  This is used with USE_REACLIB_TABLE=TRUE to
+evaluate the Reaclib rates with networks/reaclib_table.H instead of
+the generated per-rate functions.
+
+Each Reaclib set contributes
+
+    exp(a0 + a1 T9^-1 + a2 T9^-1/3 + a3 T9^1/3 + a4 T9 + a5 T9^5/3 + a6 ln T9)
+
+to its rate.  The generated rate_*() functions contain these as
+straight-line code; here we parse the ln_set_rate expressions back
+into the 7 coefficients.  Only rates that are nothing more than a sum
+of sets are put in the table -- anything else (e.g. derived rates,
+which are multiplied by partition functions) is left to its generated
+function, which the table version of fill_reaclib_rates() calls
+as before.
+"""
+
+import os
+import re
+import argparse
+
+
+# the T-factors multiplying each coefficient, in table order
+TFACTORS = ["", "T9i", "T913i", "T913", "T9", "T953", "lnT9"]
+
+RATE_FUNC_RE = re.compile(
+    r"void rate_(\w+)\(const tf_t& tfactors, amrex::Real& rate, amrex::Real& drate_dT(, [^)]*)?\) \{\n"
+    r"(.*?)\n\}\n", re.DOTALL)
+
+FILL_RE = re.compile(
+    r"rate_(\w+)<do_T_derivatives>\(tfactors, rate, drate_dT(, pf_cache)?\);\s*"
+    r"rate_eval\.screened_rates\((\w+)\) = rate;")
+
+LN_SET_RATE_RE = re.compile(r"^\s*ln_set_rate =\s*([-\d.].*?);", re.DOTALL | re.MULTILINE)
+DLN_SET_RATE_RE = re.compile(r"^\s*dln_set_rate_dT9 =\s*(.*?);", re.DOTALL | re.MULTILINE)
+
+# everything else a rate that is just a sum of sets may contain
+
+ALLOWED_LINES = [
+    r"//.*",
+    r"rate = 0\.0;",
+    r"drate_dT = 0\.0;",
+    r"amrex::Real ln_set_rate\{0\.0\};",
+    r"amrex::Real dln_set_rate_dT9\{0\.0\};",
+    r"amrex::Real set_rate\{0\.0\};",
+    r"amrex::ignore_unused\(tfactors\);",
+    r"if constexpr \(do_T_derivatives\) \{",
+    r"\}",
+    r"ln_set_rate = std::max\(ln_set_rate, -230\.0\);",
+    r"set_rate = std::exp\(ln_set_rate\);",
+    r"rate \+= set_rate;",
+    r"drate_dT \+= set_rate \* dln_set_rate_dT9 / 1\.0e9;",
+]
+ALLOWED_RE = re.compile("^(" + "|".join(ALLOWED_LINES) + ")$")
+
+
+def parse_set(expr):
+    """return the 7 coefficients of a ln_set_rate expression, or None
+    if it is not of the Reaclib form"""
+
+    coeffs = [0.0] * len(TFACTORS)
+    for term in " ".join(expr.split()).split(" + "):
+        c, _, tf = term.partition("*")
+        tf = tf.strip()
+        if tf:
+            if not tf.startswith("tfactors.") or tf[len("tfactors."):] not in TFACTORS[1:]:
+                return None
+            k = TFACTORS.index(tf[len("tfactors."):])
+        else:
+            k = 0
+        try:
+            coeffs[k] += float(c)
+        except ValueError:
+            return None
+    return coeffs
+
+
+def get_table_sets(body):
+    """return the list of sets of a rate function, or None if the rate
+    is not just their sum"""
+
+    sets = []
+    for m in LN_SET_RATE_RE.finditer(body):
+        coeffs = parse_set(m.group(1))
+        if coeffs is None:
+            return None
+        sets.append(coeffs)
+
+    remainder = DLN_SET_RATE_RE.sub("", LN_SET_RATE_RE.sub("", body))
+    for line in remainder.splitlines():
+        line = line.strip()
+        if line and not ALLOWED_RE.match(line):
+            return None
+
+    return sets
+
+
+def parse_rates(rates_file):
+    """return the rates filled by fill_reaclib_rates() as a list of
+    (function name, rate index, uses partition functions, sets or None)"""
+
+    with open(rates_file) as f:
+        source = f.read()
+
+    funcs = {}
+    for m in RATE_FUNC_RE.finditer(source):
+        name, extra_args, body = m.groups()
+        funcs[name] = None if extra_args else get_table_sets(body)
+
+    fill = source[source.index("fill_reaclib_rates("):]
+
+    rates = []
+    for m in FILL_RE.finditer(fill):
+        name, pf, index = m.groups()
+        rates.append((name, index, pf is not None, funcs.get(name)))
+
+    return rates
+
+
+def write_header(rates, net, header_name):
+    """output the coefficient table and the table version of
+    fill_reaclib_rates()"""
+
+    table = [(index, sets) for _, index, _, sets in rates if sets]
+    other = [(name, index, pf) for name, index, pf, sets in rates if not sets]
+
+    nsets = sum(len(sets) for _, sets in table)
+
+    def wrap(values, indent="       ", n=4):
+        chunks = [values[i:i+n] for i in range(0, len(values), n)]
+        return f",\n{indent}".join(", ".join(str(v) for v in c) for c in chunks)
+
+    with open(header_name, "w") as of:
+        of.write("/* Do not edit -- this is automatically generated by write_reaclib_table.py\n")
+        of.write("   at compile time */\n\n")
+        of.write("#ifndef REACLIB_RATE_TABLE_H\n")
+        of.write("#define REACLIB_RATE_TABLE_H\n\n")
+        of.write("#include <type_traits>\n\n")
+        of.write("#include <AMReX_REAL.H>\n\n")
+        of.write("#include <reaclib_rates.H>\n")
+        of.write("#include <reaclib_table.H>\n\n")
+        of.write("using namespace amrex::literals;\n\n")
+        of.write(f"// network: {net}\n")
+        of.write(f"// rates in the table: {len(table)} of {len(rates)}\n")
+        of.write(f"// Reaclib sets in the table: {nsets}\n\n")
+
+        of.write("namespace reaclib_rate_table {\n\n")
+        of.write(f"    constexpr int nsets = {max(nsets, 1)};\n\n")
+
+        # coefficient-major, so the product with the T-factors runs
+        # over contiguous sets
+
+        of.write("    // coefficient k of set s is coeffs[k * nsets + s], for the T-factors\n")
+        of.write("    // 1, T9^-1, T9^-1/3, T9^1/3, T9, T9^5/3, ln T9\n")
+        of.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED amrex::Real "
+                 f"coeffs[reaclib_table::ncoeff * nsets] = {{\n")
+        for k, tf in enumerate(TFACTORS):
+            values = [repr(sets[i][k]) for _, sets in table for i in range(len(sets))]
+            if not values:
+                values = ["0.0"]
+            sep = "," if k < len(TFACTORS) - 1 else ""
+            of.write(f"       // {tf if tf else 'constant'}\n")
+            of.write(f"       {wrap(values)}{sep}\n")
+        of.write("    };\n\n")
+
+        of.write("    // the rate (index into Rates) of each set -- the sets of a rate\n")
+        of.write("    // are contiguous\n")
+        of.write("    MICROPHYSICS_UNUSED HIP_CONSTEXPR static AMREX_GPU_MANAGED int "
+                 "set_rate[nsets] = {\n")
+        indices = [index for index, sets in table for _ in sets]
+        if not indices:
+            indices = ["1"]
+        of.write(f"       {wrap(indices, n=3)}\n")
+        of.write("    };\n\n")
+
+        of.write("}\n\n")
+
+        of.write("// fill_reaclib_rates(), with the rates that are only a sum of Reaclib\n")
+        of.write("// sets evaluated from the table\n\n")
+        of.write("template <int do_T_derivatives, typename T>\n")
+        of.write("AMREX_GPU_HOST_DEVICE AMREX_INLINE\n")
+        of.write("void\n")
+        of.write("fill_reaclib_rates_table(const tf_t& tfactors, T& rate_eval)\n")
+        of.write("{\n\n")
+
+        if table:
+            of.write("    reaclib_table_rates<do_T_derivatives, reaclib_rate_table::nsets>\n")
+            of.write("        (tfactors, reaclib_rate_table::coeffs, reaclib_rate_table::set_rate, rate_eval);\n\n")
+
+        if other:
+            of.write("    // the rates that are not in the table\n\n")
+            of.write("    amrex::Real rate;\n")
+            of.write("    amrex::Real drate_dT;\n\n")
+            if any(pf for _, _, pf in other):
+                of.write("    part_fun::pf_cache_t pf_cache{};\n\n")
+            for name, index, pf in other:
+                args = "tfactors, rate, drate_dT, pf_cache" if pf else "tfactors, rate, drate_dT"
+                of.write(f"    rate_{name}<do_T_derivatives>({args});\n")
+                of.write(f"    rate_eval.screened_rates({index}) = rate;\n")
+                of.write("    if constexpr (std::is_same_v<T, rate_derivs_t>) {\n")
+                of.write(f"        rate_eval.dscreened_rates_dT({index}) = drate_dT;\n")
+                of.write("    }\n")
+
+        if not table and not other:
+            of.write("    amrex::ignore_unused(tfactors, rate_eval);\n")
+
+        of.write("\n}\n\n")
+        of.write("#endif\n")
+
+
+def main():
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--microphysics_path", type=str, default="",
+                        help="path to Microphysics/")
+    parser.add_argument("--net", type=str, default="",
+                        help="name of the network")
+    parser.add_argument("--odir", type=str, default="",
+                        help="output directory")
+
+    args = parser.parse_args()
+
+    rates_file = os.path.join(args.microphysics_path, "networks", args.net, "reaclib_rates.H")
+
+    rates = parse_rates(rates_file)
+
+    try:
+        os.makedirs(args.odir)
+    except FileExistsError:
+        pass
+
+    write_header(rates, args.net, os.path.join(args.odir, "reaclib_rate_table.H"))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+
+# Convert a text NSE table (as written by make_nse_table.py) into the
+# binary form that the C++ NSE code can read without parsing or map
+# directly into memory (set network.nse_table_file to the binary
+# file).  The mass fractions can optionally be stored in reduced
+# precision (--massfrac float or log16) to shrink the table -- the
+# storage must match the NSE_TABLE_MASSFRAC_STORAGE the code was built
+# with for the table to be mapped.
+#
+# The layout of the binary table is described in nse_table_io.H.
+
+import argparse
+import math
+import struct
+import zlib
+
+# for the binary table
+MAGIC = b'NSETAB\0\0'
+ENDIAN_TAG = 0x01020304
+VERSION = 1
+
+# the number of columns before the mass fractions: rho, T, Ye, then
+# the six 1-d tables
+NCOLS_1D = 9
+
+# mass fraction storage -- this must match massfrac_storage_t in
+# nse_table_data.H.  Each is (id, struct format)
+STORAGE = {'double': (0, 'd'), 'float': (1, 'f'), 'log16': (2, 'H')}
+
+# the log10(X) range of the log16 quantization
+LOG16_MIN = -20.0
+LOG16_DLOG = -LOG16_MIN / 65534.0
+
+
+def read_table(table_name):
+    """read the text table, returning the table dimensions (nden,
+    ntemp, nye) and the rows.  The rows are already in the order the
+    C++ code stores the points (rho varying slowest, Ye fastest)"""
+
+    rows = []
+    with open(table_name, 'r') as table:
+        for line in table:
+            if line.startswith('#') or not line.strip():
+                continue
+            rows.append([float(v) for v in line.split()])
+
+    if not rows or len(rows[0]) <= NCOLS_1D:
+        raise ValueError(f'error reading {table_name}: there are no mass fractions')
+
+    ncols = len(rows[0])
+    if any(len(row) != ncols for row in rows):
+        raise ValueError(f'error reading {table_name}: the rows have different lengths')
+
+    ntemp = len({row[0] for row in rows})
+    nden = len({row[1] for row in rows})
+    nye = len({row[2] for row in rows})
+
+    if nden * ntemp * nye != len(rows):
+        raise ValueError(f'error reading {table_name}: the table is not a complete rho x T x Ye grid')
+
+    return nden, ntemp, nye, rows
+
+
+def encode_log16(X):
+    """quantize a mass fraction to a 16-bit integer in log10(X)"""
+
+    if X <= 0.0:
+        return 0
+    q = (math.log10(X) - LOG16_MIN) / LOG16_DLOG
+    if q < -0.5:
+        return 0
+    return 1 + min(65534, round(max(q, 0.0)))
+
+
+def decode_log16(q):
+    """a mass fraction stored as a 16-bit integer"""
+
+    if q == 0:
+        return 0.0
+    return 10.0**(LOG16_MIN + (q - 1) * LOG16_DLOG)
+
+
+def write_binary(nden, ntemp, nye, rows, storage, binary_file):
+    """write the table as the six 1-d tables (doubles) followed by the
+    mass fractions in the requested storage, preceded by a header with
+    the table dimensions and a checksum.  Returns the full precision
+    mass fractions and the ones that will be read back."""
+
+    storage_id, fmt = STORAGE[storage]
+    nspec = len(rows[0]) - NCOLS_1D
+
+    data = bytearray()
+    for m in range(3, NCOLS_1D):
+        data += struct.pack(f'<{len(rows)}d', *[row[m] for row in rows])
+
+    X = [x for row in rows for x in row[NCOLS_1D:]]
+
+    if storage == 'log16':
+        stored = [encode_log16(x) for x in X]
+        X_read = [decode_log16(q) for q in stored]
+    else:
+        stored = X
+        X_read = list(struct.unpack(f'<{len(X)}{fmt}', struct.pack(f'<{len(X)}{fmt}', *X)))
+
+    data += struct.pack(f'<{len(stored)}{fmt}', *stored)
+
+    checksum = zlib.crc32(data) & 0xffffffff
+
+    header = struct.pack('<8sIIiiiiiiQII', MAGIC, ENDIAN_TAG, VERSION,
+                         nden, ntemp, nye, nspec, storage_id, 0,
+                         len(data), checksum, 0)
+    assert len(header) == 56
+
+    with open(binary_file, 'wb') as out:
+        out.write(header)
+        out.write(data)
+
+    return X, X_read
+
+
+def report_accuracy(X, X_read, storage, binary_file):
+    """report how much the reduced-precision storage changes the mass
+    fractions"""
+
+    max_abs_err = 0.0
+    max_rel_err = 0.0
+    nzeroed = 0
+
+    for x, x_read in zip(X, X_read):
+        err = abs(x_read - x)
+        max_abs_err = max(max_abs_err, err)
+        if x > 1.e-10:
+            max_rel_err = max(max_rel_err, err / x)
+        if x > 0.0 and x_read == 0.0:
+            nzeroed += 1
+
+    print(f'wrote {binary_file} with the mass fractions stored as {storage}')
+    print(f'   max absolute error in X = {max_abs_err:.6g}')
+    print(f'   max relative error in X (for X > 1.e-10) = {max_rel_err:.6g}')
+    print(f'   number of nonzero X stored as zero = {nzeroed}')
+
+
+def main():
+
+    parser = argparse.ArgumentParser(description='convert a text NSE table to the binary format')
+    parser.add_argument('table', help='the text table to read')
+    parser.add_argument('--massfrac', choices=list(STORAGE), default='double',
+                        help='how to store the mass fractions')
+    parser.add_argument('-o', '--output', default=None,
+                        help='output file (default: the table name with a .bin extension)')
+    args = parser.parse_args()
+
+    output = args.output
+    if output is None:
+        output = args.table.rsplit('.', 1)[0] + '.bin'
+
+    nden, ntemp, nye, rows = read_table(args.table)
+    X, X_read = write_binary(nden, ntemp, nye, rows, args.massfrac, output)
+    report_accuracy(X, X_read, args.massfrac, output)
+
+
+if __name__ == '__main__':
+    main()
@@ -1,15 +1,54 @@
+#include <AMReX.H>
+#include <AMReX_Arena.H>
+
 #include <nse_table_data.H>
 
 #ifdef NSE_TABLE
+namespace
+{
+    void* managed_table = nullptr;
+
+    bool registered = false;
+}
+
 namespace nse_table
 {
-    AMREX_GPU_MANAGED amrex::Array1D<amrex::Real, 1, npts> abartab;
-    AMREX_GPU_MANAGED amrex::Array1D<amrex::Real, 1, npts> beatab;
-    AMREX_GPU_MANAGED amrex::Array1D<amrex::Real, 1, npts> dyedttab;
-    AMREX_GPU_MANAGED amrex::Array1D<amrex::Real, 1, npts> dabardttab;
-    AMREX_GPU_MANAGED amrex::Array1D<amrex::Real, 1, npts> dbeadttab;
-    AMREX_GPU_MANAGED amrex::Array1D<amrex::Real, 1, npts> enutab;
+    AMREX_GPU_MANAGED table_1d_t abartab;
+    AMREX_GPU_MANAGED table_1d_t beatab;
+    AMREX_GPU_MANAGED table_1d_t dyedttab;
+    AMREX_GPU_MANAGED table_1d_t dabardttab;
+    AMREX_GPU_MANAGED table_1d_t dbeadttab;
+    AMREX_GPU_MANAGED table_1d_t enutab;
+
+    AMREX_GPU_MANAGED massfrac_table_t<massfrac_storage> massfractab;
+}
+
+
+void*
+nse_table::allocate_managed_nse_table (const std::size_t nbytes)
+{
+    release_managed_nse_table();
+
+    if (!registered) {
+        amrex::ExecOnFinalize([] () {
+            nse_table::release_managed_nse_table();
+            registered = false;
+        });
+        registered = true;
+    }
+
+    managed_table = amrex::The_Managed_Arena()->alloc(nbytes);
 
-    AMREX_GPU_MANAGED amrex::Array2D<amrex::Real, 1, NumSpec, 1, npts> massfractab;
+    return managed_table;
+}
+
+
+void
+nse_table::release_managed_nse_table ()
+{
+    if (managed_table != nullptr) {
+        amrex::The_Managed_Arena()->free(managed_table);
+        managed_table = nullptr;
+    }
 }
 #endif
@@ -0,0 +1,154 @@
+#include <cstring>
+#include <fstream>
+
+#include <AMReX.H>
+
+#include <crc32.H>
+#include <mapped_file.H>
+#include <nse_table_data.H>
+#include <nse_table_io.H>
+
+#ifdef NSE_TABLE
+
+namespace
+{
+    // the current mapping, if any
+    const void* map_addr = nullptr;
+
+    void check_header (const nse_table::nse_table_header_t& hdr,
+                       const std::string& filename)
+    {
+        using namespace nse_table;
+
+        if (std::memcmp(hdr.magic, nse_table_magic, sizeof(nse_table_magic)) != 0) {
+            amrex::Error(filename + " is not a binary NSE table");
+        }
+
+        if (hdr.endian_tag != nse_table_endian_tag) {
+            amrex::Error(filename + " was written with a different byte order than this machine uses");
+        }
+
+        if (hdr.version != nse_table_version) {
+            amrex::Error(filename + " has an unsupported binary table version");
+        }
+
+        if (hdr.nden != nse_table_size::nden ||
+            hdr.ntemp != nse_table_size::ntemp ||
+            hdr.nye != nse_table_size::nye ||
+            hdr.nspec != NumSpec) {
+            amrex::Error(filename + " does not match the NSE table size of the network");
+        }
+
+        if (hdr.massfrac_storage < massfrac_real || hdr.massfrac_storage > massfrac_log16 ||
+            hdr.nbytes != binary_nse_table_nbytes(hdr.massfrac_storage)) {
+            amrex::Error(filename + " has an invalid mass fraction storage");
+        }
+    }
+}
+
+
+std::size_t
+nse_table::binary_nse_table_nbytes (const int massfrac_storage)
+{
+    // the 1-d tables are always doubles in the file, as are full
+    // precision mass fractions
+
+    std::size_t xsize = sizeof(double);
+    if (massfrac_storage == massfrac_float) {
+        xsize = sizeof(float);
+    } else if (massfrac_storage == massfrac_log16) {
+        xsize = sizeof(std::uint16_t);
+    }
+
+    return static_cast<std::size_t>(6) * npts * sizeof(double) +
+           static_cast<std::size_t>(NumSpec) * npts * xsize;
+}
+
+
+bool
+nse_table::is_binary_nse_table (const std::string& filename)
+{
+    std::ifstream table(filename, std::ios::binary);
+
+    char magic[sizeof(nse_table_magic)];
+    if (!table.read(magic, sizeof(magic))) {
+        return false;
+    }
+
+    return std::memcmp(magic, nse_table_magic, sizeof(nse_table_magic)) == 0;
+}
+
+
+nse_table::nse_table_header_t
+nse_table::read_nse_table_header (const std::string& filename)
+{
+    std::ifstream table(filename, std::ios::binary);
+
+    if (!table.is_open()) {
+        amrex::Error("unable to open NSE table: " + filename);
+    }
+
+    nse_table_header_t hdr{};
+    if (!table.read(reinterpret_cast<char*>(&hdr), sizeof(hdr))) {
+        amrex::Error("Error reading the header of " + filename);
+    }
+
+    check_header(hdr, filename);
+
+    return hdr;
+}
+
+
+void
+nse_table::read_binary_nse_table (const std::string& filename, void* data)
+{
+    const nse_table_header_t hdr = read_nse_table_header(filename);
+
+    std::ifstream table(filename, std::ios::binary);
+    table.seekg(sizeof(nse_table_header_t));
+
+    if (!table.read(static_cast<char*>(data), static_cast<std::streamsize>(hdr.nbytes))) {
+        amrex::Error("Error reading the data of " + filename);
+    }
+
+    check_nse_table_checksum(filename, data);
+}
+
+
+void
+nse_table::check_nse_table_checksum (const std::string& filename, const void* data)
+{
+    const nse_table_header_t hdr = read_nse_table_header(filename);
+
+    if (crc32_checksum(data, hdr.nbytes) != hdr.checksum) {
+        amrex::Error(filename + " is corrupt (checksum mismatch)");
+    }
+}
+
+
+const void*
+nse_table::map_binary_nse_table (const std::string& filename)
+{
+    unmap_binary_nse_table();
+
+    const nse_table_header_t hdr = read_nse_table_header(filename);
+
+    map_addr = mapped_file::map(filename, sizeof(nse_table_header_t) + hdr.nbytes);
+    if (map_addr == nullptr) {
+        return nullptr;
+    }
+
+    return static_cast<const char*>(map_addr) + sizeof(nse_table_header_t);
+}
+
+
+void
+nse_table::unmap_binary_nse_table ()
+{
+    if (map_addr != nullptr) {
+        mapped_file::unmap(map_addr);
+    }
+    map_addr = nullptr;
+}
+
+#endif
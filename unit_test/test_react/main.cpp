@@ -14,6 +14,8 @@ using namespace amrex;
 #include <eos.H>
 #include <network.H>
 #include <react_zones.H>
+#include <react_classified.H>
+#include <integrator_stats_summary.H>
 #include <AMReX_buildInfo.H>
 #include <variables.H>
 #include <unit_test.H>
@@ -184,6 +186,10 @@ void main_main ()
     // so we can manually do the reductions (for GPU)
     iMultiFab integrator_n_rhs(ba, dm, 2, Nghost);
 
+    // the cost of the burn in each zone, for load balancing
+    MultiFab burn_cost_mf(ba, dm, burn_cost_ncomp, Nghost);
+    burn_cost_mf.setVal(0.0_rt);
+
     // What time is it now?  We'll use this to compute total react time.
     Real strt_time = ParallelDescriptor::second();
 
@@ -193,12 +199,52 @@ void main_main ()
 
     ValLocPair<int, burn_t> r;
 
-    {
+    if (use_batch_burner) {
+        BL_PROFILE("do_react_batch");
+
+#ifdef AMREX_USE_GPU
+        amrex::Abort("use_batch_burner is only supported on the CPU");
+#endif
+
+        // burn batch_width zones at a time with the batched burner
+
+        constexpr int batch_width = 8;
+
+        r.value = -1;
+
+        for (MFIter mfi(state); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.validbox();
+
+            auto s = state.array(mfi);
+            auto n_rhs = integrator_n_rhs.array(mfi);
+            auto cost = burn_cost_mf.array(mfi);
+
+            Real box_strt_time = ParallelDescriptor::second();
+
+            num_failed += do_react_batch<batch_width>(bx, s, n_rhs, cost, vars, r.index, r.value);
+
+            add_burn_wall_time(bx, burn_cost_mf[mfi], ParallelDescriptor::second() - box_strt_time);
+        }
+
+    } else if (use_zone_classes) {
+        BL_PROFILE("do_react_classified");
+
+#ifdef AMREX_USE_GPU
+        amrex::Abort("use_zone_classes is only supported on the CPU");
+#endif
+
+        r.value = -1;
+
+        num_failed = do_react_classified(state, integrator_n_rhs, burn_cost_mf, vars, r.index, r.value);
+
+    } else {
         BL_PROFILE("do_react");
 
         // Do the reactions
         auto const& ma = state.arrays();
         auto const& ia = integrator_n_rhs.arrays();
+        auto const& ca = burn_cost_mf.arrays();
 
         r = amrex::ParReduce(TypeList<ReduceOpMax>{}, TypeList<ValLocPair<int, burn_t>>{}, state,
         [=] AMREX_GPU_DEVICE (int box_no, int i, int j, int k) -> GpuTuple<ValLocPair<int, burn_t>>
@@ -206,9 +252,10 @@ void main_main ()
 
             Array4<Real> const& s = ma[box_no];
             auto n_rhs = ia[box_no];
+            Array4<Real> const& cost = ca[box_no];
 
             burn_t burn_state;
-            bool success = do_react(i, j, k, s, burn_state, n_rhs, vars);
+            bool success = do_react(i, j, k, s, burn_state, n_rhs, cost, vars);
 
             if (!success) {
                 Gpu::Atomic::Add(num_failed_d, 1);
@@ -219,8 +266,10 @@ void main_main ()
 
     }
 
-    aa_num_failed.copyToHost(&num_failed, 1);
-    Gpu::synchronize();
+    if (!use_batch_burner && !use_zone_classes) {
+        aa_num_failed.copyToHost(&num_failed, 1);
+        Gpu::synchronize();
+    }
 
     if (num_failed > 0) {
         amrex::Abort("Integration failed");
@@ -282,6 +331,26 @@ void main_main ()
 
     }
 
+#ifdef INTEGRATOR_STATS
+    // the per-zone statistics are in the plotfile -- here we summarize
+    // them over the zones and ranks
+    integrator_stats_summary(state, vars.istats);
+#endif
+
+    // how well is the cost of the burn balanced across the MPI ranks,
+    // and how well would it be with a knapsack distribution based on
+    // the measured cost?
+
+    DistributionMapping dm_cost = burn_cost_distribution_map(burn_cost_mf, burn_cost_work);
+
+    Real efficiency = burn_cost_efficiency(burn_cost_mf, burn_cost_work, dm);
+    Real efficiency_cost = burn_cost_efficiency(burn_cost_mf, burn_cost_work, dm_cost);
+
+    if (ParallelDescriptor::IOProcessor()) {
+        std::cout << "burn load balance efficiency: " << efficiency
+                  << " (with cost-based distribution: " << efficiency_cost << ")" << std::endl;
+    }
+
     // output the state that took the most time
 
     if (ParallelDescriptor::IOProcessor()) {
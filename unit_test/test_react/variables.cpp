@@ -1,5 +1,6 @@
 #include <variables.H>
 #include <network.H>
+#include <integrator_stats.H>
 
 plot_t init_variables() {
 
@@ -19,6 +20,10 @@ plot_t init_variables() {
   p.irodot = p.next_index(NumSpec);
   p.irho_hnuc = p.next_index(1);
 
+#ifdef INTEGRATOR_STATS
+  p.istats = p.next_index(integrator_stats_ncomp);
+#endif
+
   return p;
 
 }
@@ -44,5 +49,11 @@ void get_varnames(const plot_t& p, amrex::Vector<std::string>& names) {
 #endif
 
   names[p.irho_hnuc] = "rho_Hnuc";
+
+#ifdef INTEGRATOR_STATS
+  for (int n = 0; n < integrator_stats_ncomp; n++) {
+      names[p.istats + n] = integrator_stats_names[n];
+  }
+#endif
 }
 
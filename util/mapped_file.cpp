@@ -0,0 +1,64 @@
+#include <map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <mapped_file.H>
+
+namespace
+{
+    // the length of each mapping, for unmapping
+    std::map<const void*, std::size_t> mappings;
+}
+
+
+const void*
+mapped_file::map (const std::string& filename, std::size_t len)
+{
+#ifdef _WIN32
+    (void) filename;
+    (void) len;
+    return nullptr;
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat sb{};
+    if (fstat(fd, &sb) != 0 || static_cast<std::size_t>(sb.st_size) < len) {
+        close(fd);
+        return nullptr;
+    }
+
+    void* addr = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED) {
+        return nullptr;
+    }
+
+    mappings[addr] = len;
+
+    return addr;
+#endif
+}
+
+
+void
+mapped_file::unmap (const void* addr)
+{
+    auto it = mappings.find(addr);
+    if (it == mappings.end()) {
+        return;
+    }
+
+#ifndef _WIN32
+    munmap(const_cast<void*>(addr), it->second);
+#endif
+    mappings.erase(it);
+}
@@ -0,0 +1,120 @@
+#include <vector>
+
+#include <AMReX.H>
+#include <AMReX_ParallelDescriptor.H>
+
+#include <node_shared_memory.H>
+
+namespace
+{
+#ifdef AMREX_USE_MPI
+    MPI_Comm node_comm = MPI_COMM_NULL;
+    std::vector<MPI_Win> windows;
+
+    // windows before this one have already been through fence()
+    std::size_t nfenced = 0;
+
+    MPI_Comm get_node_comm ()
+    {
+        if (node_comm == MPI_COMM_NULL) {
+            MPI_Comm_split_type(amrex::ParallelDescriptor::Communicator(),
+                                MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm);
+        }
+        return node_comm;
+    }
+#endif
+
+    // allocations without MPI
+    std::vector<std::vector<char>> buffers;
+
+    bool registered = false;
+}
+
+
+void*
+node_shared_memory::allocate_bytes (std::size_t nbytes, bool& writer)
+{
+    // everything is freed before MPI is finalized
+
+    if (!registered) {
+        amrex::ExecOnFinalize(node_shared_memory::release_all);
+        registered = true;
+    }
+
+#ifdef AMREX_USE_MPI
+    MPI_Comm comm = get_node_comm();
+
+    int node_rank{};
+    MPI_Comm_rank(comm, &node_rank);
+
+    writer = node_rank == 0;
+
+    // the writer allocates all of the memory, the others none, and
+    // then they find the writer's piece
+
+    MPI_Win win{};
+    void* base{};
+    const auto size = static_cast<MPI_Aint>(writer ? nbytes : 0);
+    if (MPI_Win_allocate_shared(size, 1, MPI_INFO_NULL, comm, &base, &win) != MPI_SUCCESS) {
+        amrex::Error("unable to allocate node-shared memory");
+    }
+
+    MPI_Aint query_size{};
+    int disp_unit{};
+    MPI_Win_shared_query(win, 0, &query_size, &disp_unit, &base);
+
+    windows.push_back(win);
+
+    return base;
+#else
+    writer = true;
+    buffers.emplace_back(nbytes);
+    return buffers.back().data();
+#endif
+}
+
+
+void
+node_shared_memory::fence ()
+{
+#ifdef AMREX_USE_MPI
+    // the fence completes the writer's stores and makes them visible
+    // to the other ranks on the node
+    for (; nfenced < windows.size(); ++nfenced) {
+        MPI_Win_fence(0, windows[nfenced]);
+    }
+#endif
+}
+
+
+void
+node_shared_memory::release_all ()
+{
+#ifdef AMREX_USE_MPI
+    for (auto& win : windows) {
+        MPI_Win_free(&win);
+    }
+    windows.clear();
+    nfenced = 0;
+
+    if (node_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&node_comm);
+        node_comm = MPI_COMM_NULL;
+    }
+#endif
+    buffers.clear();
+    registered = false;
+}
+
+
+int
+node_shared_memory::node_size ()
+{
+#ifdef AMREX_USE_MPI
+    int size{};
+    MPI_Comm_size(get_node_comm(), &size);
+    return size;
+#else
+    return 1;
+#endif
+}